@@ -24,65 +24,13 @@ SimpleMBCompAudioProcessor::SimpleMBCompAudioProcessor()
 {
 	using namespace juce;
 	using namespace Parameters;
-	const auto& params= GetParams();
-
-	lowBandComprosser.attackParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::A_L_B)));
-	jassert(lowBandComprosser.attackParameter != nullptr);
-	midBandComprosser.attackParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::A_M_B)));
-	jassert(midBandComprosser.attackParameter != nullptr);
-	highBandComprosser.attackParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::A_H_B)));
-	jassert(highBandComprosser.attackParameter != nullptr);
-
-	lowBandComprosser.releaseParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::R_L_B)));
-	jassert(lowBandComprosser.releaseParameter != nullptr);
-	midBandComprosser.releaseParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::R_M_B)));
-	jassert(midBandComprosser.releaseParameter != nullptr);
-	highBandComprosser.releaseParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::R_H_B)));
-	jassert(highBandComprosser.releaseParameter != nullptr);
-
-	lowBandComprosser.ratioParameter = dynamic_cast<AudioParameterChoice*>(apvts.getParameter(params.at(Parameters::RT_L_B)));
-	jassert(lowBandComprosser.ratioParameter != nullptr);
-	midBandComprosser.ratioParameter = dynamic_cast<AudioParameterChoice*>(apvts.getParameter(params.at(Parameters::RT_M_B)));
-	jassert(midBandComprosser.ratioParameter != nullptr);
-	highBandComprosser.ratioParameter = dynamic_cast<AudioParameterChoice*>(apvts.getParameter(params.at(Parameters::RT_H_B)));
-	jassert(highBandComprosser.ratioParameter != nullptr);
-	
-	lowBandComprosser.tresholdParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::TD_L_B)));
-	jassert(lowBandComprosser.tresholdParameter != nullptr);
-	midBandComprosser.tresholdParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::TD_M_B)));
-	jassert(midBandComprosser.tresholdParameter != nullptr);
-	highBandComprosser.tresholdParameter = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::TD_H_B)));
-	jassert(highBandComprosser.tresholdParameter != nullptr);
-	
-
-	lowBandComprosser.byPassedParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::By_L_B)));
-	jassert(lowBandComprosser.byPassedParameter != nullptr);
-	midBandComprosser.byPassedParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::By_M_B)));
-	jassert(midBandComprosser.byPassedParameter != nullptr);
-	highBandComprosser.byPassedParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::By_H_B)));
-	jassert(highBandComprosser.byPassedParameter != nullptr);
-
-	lowBandComprosser.SoloParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::S_L_B)));
-	jassert(lowBandComprosser.SoloParameter != nullptr);
-	midBandComprosser.SoloParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::S_M_B)));
-	jassert(midBandComprosser.SoloParameter != nullptr);
-	highBandComprosser.SoloParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::S_H_B)));
-	jassert(highBandComprosser.SoloParameter != nullptr);
-
-	lowBandComprosser.muteParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::M_L_B)));
-	jassert(lowBandComprosser.muteParameter != nullptr);
-	midBandComprosser.muteParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::M_M_B)));
-	jassert(midBandComprosser.muteParameter != nullptr);
-	highBandComprosser.muteParameter = dynamic_cast<AudioParameterBool*>(apvts.getParameter(params.at(Parameters::M_H_B)));
-	jassert(highBandComprosser.muteParameter != nullptr);
-	
-
-	lMCrossOver = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::L_M_CR_F)));
-	jassert(lMCrossOver != nullptr);
-
-	mHCrossOver = dynamic_cast<AudioParameterFloat*>(apvts.getParameter(params.at(Parameters::M_H_CR_F)));
-	jassert(mHCrossOver != nullptr);
-	
+
+	bindBand<0>();
+	bindBand<1>();
+	bindBand<2>();
+
+	lMCrossOver = getBoundParameter<L_M_CR_F, AudioParameterFloat>();
+	mHCrossOver = getBoundParameter<M_H_CR_F, AudioParameterFloat>();
 
 	// Low and high pass type is set
 
@@ -153,8 +101,10 @@ void SimpleMBCompAudioProcessor::changeProgramName(int index, const juce::String
 //==============================================================================
 void SimpleMBCompAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
 	using namespace juce;
+	// The DSP runs in fixed quanta, so nothing here depends on the announced host block size.
+	ignoreUnused(samplesPerBlock);
 	dsp::ProcessSpec spec;
-	spec.maximumBlockSize = samplesPerBlock;
+	spec.maximumBlockSize = processingQuantum;
 	spec.numChannels = getTotalNumOutputChannels();
 	spec.sampleRate = sampleRate;
 
@@ -167,11 +117,14 @@ void SimpleMBCompAudioProcessor::prepareToPlay(double sampleRate, int samplesPer
 	HP1.prepare(spec);
 	AP2.prepare(spec);
 
-	
-	for (auto& buffer : filterBuffers) {
-		buffer.setSize(spec.numChannels, samplesPerBlock);
-	}
+	governor.prepare(sampleRate);
+	allPassActive = true;
 
+	auto arena = dsp::AudioBlock<float>(bandArena, spec.numChannels * (bandBlocks.size() + 1), processingQuantum);
+	for (size_t i = 0; i < bandBlocks.size(); i++) {
+		bandBlocks[i] = arena.getSubsetChannelBlock(i * spec.numChannels, spec.numChannels);
+	}
+	allPassFadeBlock = arena.getSubsetChannelBlock(bandBlocks.size() * spec.numChannels, spec.numChannels);
 }
 
 void SimpleMBCompAudioProcessor::releaseResources() {
@@ -206,6 +159,7 @@ bool SimpleMBCompAudioProcessor::isBusesLayoutSupported(const BusesLayout& layou
 
 void SimpleMBCompAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
 	juce::ScopedNoDenormals noDenormals;
+	const auto startTicks = juce::Time::getHighResolutionTicks();
 	auto totalNumInputChannels = getTotalNumInputChannels();
 	auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -218,15 +172,42 @@ void SimpleMBCompAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
 	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
 		buffer.clear(i, 0, buffer.getNumSamples());
 
+	updateControls();
+	const auto lowBandAllPass = governor.getTier() != QualityTier::Economy;
+
+	auto AreBandSolo = false;
+	for( auto& comp : cmds_) {
+		if(comp.SoloParameter->get()) {
+			AreBandSolo = true;
+			break;
+		}
+	}
+
+	std::array<bool, 3> bandAudible;
+	for (size_t i = 0; i < cmds_.size(); i++) {
+		bandAudible[i] = AreBandSolo ? cmds_[i].SoloParameter->get() : !cmds_[i].muteParameter->get();
+	}
+
+	// The host may send more samples than announced in prepareToPlay, so walk the block in quanta
+	// instead of trusting samplesPerBlock.
+	auto block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(
+		0, juce::jmin(buffer.getNumChannels(), static_cast<int>(bandBlocks[0].getNumChannels())));
+	const auto numberOfSamples = static_cast<int>(block.getNumSamples());
+
+	for (int start = 0; start < numberOfSamples; start += processingQuantum) {
+		auto length = juce::jmin(processingQuantum, numberOfSamples - start);
+		processQuantum(block.getSubBlock(start, length), bandAudible, lowBandAllPass);
+	}
+
+	governor.update(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks),
+	                buffer.getNumSamples());
+}
+
+void SimpleMBCompAudioProcessor::updateControls() {
 	for(auto& comp : cmds_) {
 		comp.updateCmpSettings();
 	}
-	
-	
 
-	for (auto& filterBuffer : filterBuffers) {
-		filterBuffer = buffer;
-	}
 	auto cutoff = lMCrossOver->get();
 	LP1.setCutoffFrequency(cutoff);
 	HP1.setCutoffFrequency(cutoff);
@@ -236,66 +217,67 @@ void SimpleMBCompAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
 	HP2.setCutoffFrequency(cutoff2);
 	LP2.setCutoffFrequency(cutoff2);
 	AP2.setCutoffFrequency(cutoff2);
+}
+
+void SimpleMBCompAudioProcessor::processQuantum(juce::dsp::AudioBlock<float> block, const std::array<bool, 3>& bandAudible,
+                                                bool lowBandAllPass) {
+	using namespace juce;
+	const auto numberOfSamples = block.getNumSamples();
+	const auto numberOfChannels = block.getNumChannels();
 
-	auto filterBlock0Buffer = juce::dsp::AudioBlock<float>(filterBuffers[0]);
-	auto filterBlock1Buffer = juce::dsp::AudioBlock<float>(filterBuffers[1]);
-	auto filterBlock2Buffer = juce::dsp::AudioBlock<float>(filterBuffers[2]);
+	std::array<dsp::AudioBlock<float>, 3> bands;
+	for (size_t i = 0; i < bands.size(); i++) {
+		bands[i] = bandBlocks[i].getSubsetChannelBlock(0, numberOfChannels).getSubBlock(0, numberOfSamples);
+	}
 
-	auto filterBlock0Context = juce::dsp::ProcessContextReplacing<float>(filterBlock0Buffer);
-	auto filterBlock1Context = juce::dsp::ProcessContextReplacing<float>(filterBlock1Buffer);
-	auto filterBlock2Context = juce::dsp::ProcessContextReplacing<float>(filterBlock2Buffer);
+	bands[0].copyFrom(block);
+	bands[1].copyFrom(block);
 
+	auto filterBlock0Context = dsp::ProcessContextReplacing<float>(bands[0]);
+	auto filterBlock1Context = dsp::ProcessContextReplacing<float>(bands[1]);
+	auto filterBlock2Context = dsp::ProcessContextReplacing<float>(bands[2]);
 
 	LP1.process(filterBlock0Context);
-	AP2.process(filterBlock0Context);
+	if (lowBandAllPass != allPassActive) {
+		// The all-pass was skipped while in QualityTier::Economy, so its state is stale.
+		if (lowBandAllPass) {
+			AP2.reset();
+		}
+
+		auto dry = allPassFadeBlock.getSubsetChannelBlock(0, numberOfChannels).getSubBlock(0, numberOfSamples);
+		dry.copyFrom(bands[0]);
+		AP2.process(filterBlock0Context);
+
+		for (size_t channel = 0; channel < numberOfChannels; channel++) {
+			auto* wet = bands[0].getChannelPointer(channel);
+			const auto* unfiltered = dry.getChannelPointer(channel);
+			for (size_t i = 0; i < numberOfSamples; i++) {
+				auto fade = static_cast<float>(i + 1) / static_cast<float>(numberOfSamples);
+				auto wetGain = lowBandAllPass ? fade : 1.0f - fade;
+				wet[i] = unfiltered[i] + (wet[i] - unfiltered[i]) * wetGain;
+			}
+		}
+		allPassActive = lowBandAllPass;
+	} else if (allPassActive) {
+		AP2.process(filterBlock0Context);
+	}
 
 	HP1.process(filterBlock1Context);
-	filterBuffers[2] = filterBuffers[1];
+	bands[2].copyFrom(bands[1]);
 	LP2.process(filterBlock1Context);
 	HP2.process(filterBlock2Context);
 
-	cmds_[0].processBuffer(filterBuffers[0]);
-	cmds_[1].processBuffer(filterBuffers[1]);
-	cmds_[2].processBuffer(filterBuffers[2]);
-
-	auto numberOfSamplers = buffer.getNumSamples();
-	auto nOfChannels = buffer.getNumChannels();
-
-	buffer.clear();
-
-	auto AreBandSolo = false;
-	for( auto& comp : cmds_) {
-		if(comp.SoloParameter->get()) {
-			AreBandSolo = true;
-			break;
-		}
+	for (size_t i = 0; i < cmds_.size(); i++) {
+		cmds_[i].processBlock(bands[i]);
 	}
-	
-	auto addFilterBand = [numberOfChannels = nOfChannels, nSamplers = numberOfSamplers](
-		auto& inputBuffer, const auto& source) {
-		for (auto i = 0; i < numberOfChannels; i++) {
-			inputBuffer.addFrom(i, 0, source, i, 0, nSamplers);
-		}
-	};
 
-	if(AreBandSolo) {
-		for(int i = 0; i < cmds_.size(); i++) {
-			if(cmds_[i].SoloParameter->get()) {
-				addFilterBand(buffer, filterBuffers[i]);
-			}
-		}
-	} else {
-		for (int i = 0; i < cmds_.size(); i++) {
-			if(!cmds_[i].muteParameter->get()) {
-				addFilterBand(buffer, filterBuffers[i]);
-			}
+	block.clear();
+
+	for (size_t i = 0; i < bands.size(); i++) {
+		if (bandAudible[i]) {
+			block.add(bands[i]);
 		}
 	}
-	
-	addFilterBand(buffer, filterBuffers[0]);
-	addFilterBand(buffer, filterBuffers[1]);
-	addFilterBand(buffer, filterBuffers[2]);
-
 }
 
 //==============================================================================
@@ -330,71 +312,29 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleMBCompAudioProcessor::
 	APVTS::ParameterLayout layout;
 	using namespace juce;
 	using namespace Parameters;
-	const auto& params = GetParams();
-	// Threshold parameter implementation
-	
-	
-	
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::TD_L_B), params.at(Parameters::TD_L_B),
-	                                                 NormalisableRange<float>(-60, 12, 1, 1), 0));
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::TD_M_B), params.at(Parameters::TD_M_B),
-	                                                 NormalisableRange<float>(-60, 12, 1, 1), 0));
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::TD_H_B), params.at(Parameters::TD_H_B),
-	                                                 NormalisableRange<float>(-60, 12, 1, 1), 0));
-	auto attackReleaseRange = NormalisableRange<float>(5, 500, 1, 1);
-
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::A_L_B), params.at(Parameters::A_L_B),
-	                                                 attackReleaseRange, 50));
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::A_M_B), params.at(Parameters::A_M_B),
-	                                                 attackReleaseRange, 50));
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::A_H_B), params.at(Parameters::A_H_B),
-	                                                 attackReleaseRange, 50));
-
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::R_L_B), params.at(Parameters::R_L_B),
-	                                                 attackReleaseRange, 250));
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::R_M_B), params.at(Parameters::R_M_B),
-	                                                 attackReleaseRange, 250));
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::R_H_B), params.at(Parameters::R_H_B),
-	                                                 attackReleaseRange, 250));
-
-	auto choices = std::vector<double>{1, 1.5, 2, 3, 4, 5, 6, 7, 8, 9, 10, 15, 20, 50, 100};
-	StringArray stringArray;
-	for (auto choice : choices) {
-		stringArray.add(String(choice, 1));
-	}
-	layout.add(std::make_unique<AudioParameterChoice>(params.at(Parameters::RT_L_B), params.at(Parameters::RT_L_B),
-	                                                  stringArray, 3));
-	layout.add(std::make_unique<AudioParameterChoice>(params.at(Parameters::RT_M_B), params.at(Parameters::RT_M_B),
-	                                                  stringArray, 3));
-	layout.add(std::make_unique<AudioParameterChoice>(params.at(Parameters::RT_H_B), params.at(Parameters::RT_H_B),
-	                                                  stringArray, 3));
-	layout.add(
-		std::make_unique<AudioParameterBool>(params.at(Parameters::By_L_B), params.at(Parameters::By_L_B), false));
-	layout.add(													   
-		std::make_unique<AudioParameterBool>(params.at(Parameters::By_M_B), params.at(Parameters::By_M_B), false));
-	layout.add(													   
-		std::make_unique<AudioParameterBool>(params.at(Parameters::By_H_B), params.at(Parameters::By_H_B), false));
-
-	layout.add(
-		std::make_unique<AudioParameterBool>(params.at(Parameters::M_L_B), params.at(Parameters::M_L_B), false));
-	layout.add(													   
-		std::make_unique<AudioParameterBool>(params.at(Parameters::M_M_B), params.at(Parameters::M_M_B), false));
-	layout.add(													   
-		std::make_unique<AudioParameterBool>(params.at(Parameters::M_H_B), params.at(Parameters::M_H_B), false));
-
-	layout.add(
-		std::make_unique<AudioParameterBool>(params.at(Parameters::S_L_B), params.at(Parameters::S_L_B), false));
-	layout.add(
-		std::make_unique<AudioParameterBool>(params.at(Parameters::S_M_B), params.at(Parameters::S_M_B), false));
-	layout.add(
-		std::make_unique<AudioParameterBool>(params.at(Parameters::S_H_B), params.at(Parameters::S_H_B), false));
-	
-	
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::L_M_CR_F), params.at(Parameters::L_M_CR_F),
-	                                                 NormalisableRange<float>(20, 999, 1, 1), 300));
-	layout.add(std::make_unique<AudioParameterFloat>(params.at(Parameters::M_H_CR_F), params.at(Parameters::M_H_CR_F),
-	                                                 NormalisableRange<float>(1000, 20000, 1, 1), 2000));
 
+	for (const auto& spec : Registry) {
+		switch (spec.kind) {
+		case Kind::Float:
+			layout.add(std::make_unique<AudioParameterFloat>(spec.name, spec.name,
+			                                                 NormalisableRange<float>(spec.minValue, spec.maxValue,
+				                                                 spec.interval, spec.skew),
+			                                                 spec.defaultValue));
+			break;
+		case Kind::Choice: {
+			StringArray choiceNames;
+			for (size_t i = 0; i < spec.numChoices; i++) {
+				choiceNames.add(String(spec.choices[i], 1));
+			}
+			layout.add(std::make_unique<AudioParameterChoice>(spec.name, spec.name, choiceNames,
+			                                                  static_cast<int>(spec.defaultValue)));
+			break;
+		}
+		case Kind::Bool:
+			layout.add(std::make_unique<AudioParameterBool>(spec.name, spec.name, spec.defaultValue != 0));
+			break;
+		}
+	}
 
 	return layout;
 }
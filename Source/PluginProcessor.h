@@ -10,6 +10,147 @@
 
 #include <JuceHeader.h>
 
+namespace Parameters {
+	enum FreqInts {
+		L_M_CR_F,
+		M_H_CR_F,
+
+		TD_L_B,
+		TD_M_B,
+		TD_H_B,
+
+		A_L_B,
+		A_M_B,
+		A_H_B,
+
+		R_L_B,
+		R_M_B,
+		R_H_B,
+
+		RT_L_B,
+		RT_M_B,
+		RT_H_B,
+
+		By_L_B,
+		By_M_B,
+		By_H_B,
+
+		M_L_B,
+		M_M_B,
+		M_H_B,
+
+		S_L_B,
+		S_M_B,
+		S_H_B,
+		
+		Gain_in,
+		Gain_out	
+	};
+
+	enum class Kind {
+		Float,
+		Choice,
+		Bool
+	};
+
+	inline constexpr std::array<float, 15> RatioChoices{1, 1.5f, 2, 3, 4, 5, 6, 7, 8, 9, 10, 15, 20, 50, 100};
+
+	// One row per host parameter. For Kind::Choice the default is the choice index into
+	// choices, for Kind::Bool it is 0 or 1; the range fields are only read for Kind::Float.
+	struct Spec {
+		FreqInts id;
+		const char* name;
+		Kind kind;
+		float minValue;
+		float maxValue;
+		float interval;
+		float skew;
+		float defaultValue;
+		const float* choices{nullptr};
+		size_t numChoices{0};
+	};
+
+	// The order here is the order the parameters are registered with the host,
+	// so only append to it or existing automation will point at the wrong parameter.
+	// The names double as parameter IDs and must not change either.
+	inline constexpr std::array<Spec, 23> Registry{{
+		{TD_L_B, "Threshold low band", Kind::Float, -60, 12, 1, 1, 0},
+		{TD_M_B, "Threshold mid band", Kind::Float, -60, 12, 1, 1, 0},
+		{TD_H_B, "Threshold highm band", Kind::Float, -60, 12, 1, 1, 0},
+
+		{A_L_B, "Attack low band", Kind::Float, 5, 500, 1, 1, 50},
+		{A_M_B, "Attack mid band", Kind::Float, 5, 500, 1, 1, 50},
+		{A_H_B, "Attack high band", Kind::Float, 5, 500, 1, 1, 50},
+
+		{R_L_B, "Release low band", Kind::Float, 5, 500, 1, 1, 250},
+		{R_M_B, "Release mid band", Kind::Float, 5, 500, 1, 1, 250},
+		{R_H_B, "Release high band", Kind::Float, 5, 500, 1, 1, 250},
+
+		{RT_L_B, "Ratio low band", Kind::Choice, 0, 0, 0, 0, 3, RatioChoices.data(), RatioChoices.size()},
+		{RT_M_B, "Ratio mid band", Kind::Choice, 0, 0, 0, 0, 3, RatioChoices.data(), RatioChoices.size()},
+		{RT_H_B, "Ratio high band", Kind::Choice, 0, 0, 0, 0, 3, RatioChoices.data(), RatioChoices.size()},
+
+		{By_L_B, "Bypassed low band", Kind::Bool, 0, 0, 0, 0, 0},
+		{By_M_B, "Bypassed mid band", Kind::Bool, 0, 0, 0, 0, 0},
+		{By_H_B, "Bypassed high band", Kind::Bool, 0, 0, 0, 0, 0},
+
+		{M_L_B, "Mute low band", Kind::Bool, 0, 0, 0, 0, 0},
+		{M_M_B, "Mute mid band", Kind::Bool, 0, 0, 0, 0, 0},
+		{M_H_B, "Mute high band", Kind::Bool, 0, 0, 0, 0, 0},
+
+		{S_L_B, "Solo low band", Kind::Bool, 0, 0, 0, 0, 0},
+		{S_M_B, "Solo mid band", Kind::Bool, 0, 0, 0, 0, 0},
+		{S_H_B, "Solo high band", Kind::Bool, 0, 0, 0, 0, 0},
+
+		{L_M_CR_F, "Low-Mid Crossover Freq", Kind::Float, 20, 999, 1, 1, 300},
+		{M_H_CR_F, "Mid-High Crossover Freq", Kind::Float, 1000, 20000, 1, 1, 2000}
+	}};
+
+	// Position of a parameter in Registry, which is also its index in AudioProcessor::getParameters().
+	// Gain_in and Gain_out are not registered yet and return -1.
+	constexpr int indexOf(FreqInts id) {
+		for (int i = 0; i < static_cast<int>(Registry.size()); ++i) {
+			if (Registry[i].id == id)
+				return i;
+		}
+		return -1;
+	}
+
+	struct BandIds {
+		FreqInts attack;
+		FreqInts release;
+		FreqInts threshold;
+		FreqInts ratio;
+		FreqInts bypassed;
+		FreqInts mute;
+		FreqInts solo;
+	};
+
+	inline constexpr std::array<BandIds, 3> Bands{{
+		{A_L_B, R_L_B, TD_L_B, RT_L_B, By_L_B, M_L_B, S_L_B},
+		{A_M_B, R_M_B, TD_M_B, RT_M_B, By_M_B, M_M_B, S_M_B},
+		{A_H_B, R_H_B, TD_H_B, RT_H_B, By_H_B, M_H_B, S_H_B}
+	}};
+
+	constexpr bool isBound(FreqInts id, Kind kind) {
+		return indexOf(id) >= 0 && Registry[indexOf(id)].kind == kind;
+	}
+
+	constexpr bool bandsAreBound() {
+		for (const auto& band : Bands) {
+			if (!isBound(band.attack, Kind::Float) || !isBound(band.release, Kind::Float)
+				|| !isBound(band.threshold, Kind::Float) || !isBound(band.ratio, Kind::Choice)
+				|| !isBound(band.bypassed, Kind::Bool) || !isBound(band.mute, Kind::Bool)
+				|| !isBound(band.solo, Kind::Bool))
+				return false;
+		}
+		return isBound(L_M_CR_F, Kind::Float) && isBound(M_H_CR_F, Kind::Float);
+	}
+
+	static_assert(bandsAreBound(), "Every band and crossover parameter needs a Registry row of the matching kind");
+
+}
+
 struct ComprosserBand {
 public:
 
@@ -20,6 +161,8 @@ public:
 	juce::AudioParameterBool* byPassedParameter{nullptr};
 	juce::AudioParameterBool* muteParameter{nullptr};
 	juce::AudioParameterBool* SoloParameter{nullptr};
+	// Choice list of the ratio parameter's Registry row, indexed by its current choice.
+	const float* ratioChoices{nullptr};
 
 	void setReady(const juce::dsp::ProcessSpec& s) {
 		cmp.prepare(s);
@@ -31,13 +174,12 @@ public:
 		cmp.setAttack(attackParameter->get());
 		cmp.setRelease(releaseParameter->get());
 		cmp.setThreshold(tresholdParameter->get());
-		cmp.setRatio(ratioParameter->getCurrentChoiceName().getFloatValue());
+		cmp.setRatio(ratioChoices[ratioParameter->getIndex()]);
 	};
 
-	void processBuffer(juce::AudioBuffer<float>& b) {
+	void processBlock(juce::dsp::AudioBlock<float> aBlock) {
 		using namespace juce;
 
-		auto aBlock = dsp::AudioBlock<float>(b);
 		auto context = dsp::ProcessContextReplacing<float>(aBlock);
 		context.isBypassed = byPassedParameter->get();
 		cmp.process(context);
@@ -47,79 +189,78 @@ private:
 };
 
 
-namespace Parameters {
-	enum FreqInts {
-		L_M_CR_F,
-		M_H_CR_F,
-
-		TD_L_B,
-		TD_M_B,
-		TD_H_B,
-
-		A_L_B,
-		A_M_B,
-		A_H_B,
+// Tiers the processor steps down through when it gets close to its real-time budget.
+// Economy drops the low band's all-pass, one of the five crossover filters run per sample. That all-pass
+// matches the low band's phase to the mid-high split of the upper path, so without it the low and mid
+// bands no longer sum flat and a dip/colouration appears around the low-mid crossover frequency.
+// Turning the all-pass off or on is crossfaded over one processing quantum.
+enum class QualityTier {
+	Full,		// full crossover
+	Economy		// without the low band all-pass
+};
 
-		R_L_B,
-		R_M_B,
-		R_H_B,
+struct CpuLoadGovernor {
+public:
 
-		RT_L_B,
-		RT_M_B,
-		RT_H_B,
+	void prepare(double newSampleRate) {
+		sampleRate = newSampleRate;
+		smoothedLoad = 0;
+		secondsSinceChange = 0;
+		secondsWithHeadroom = 0;
+		load.store(0.f);
+		tier.store(QualityTier::Full);
+	};
 
-		By_L_B,
-		By_M_B,
-		By_H_B,
+	// Called at the end of processBlock with its own cost; the new tier applies from the next block,
+	// so measuring adds no latency.
+	void update(double elapsedSeconds, int numSamples) {
+		if (sampleRate <= 0 || numSamples <= 0)
+			return;
+
+		const auto budget = numSamples / sampleRate;
+		// Derived from the block duration so the smoothing time is the same whatever block size the host uses.
+		const auto smoothing = 1.0 - std::exp(-budget / loadTimeConstantSeconds);
+		smoothedLoad += (elapsedSeconds / budget - smoothedLoad) * smoothing;
+		load.store(static_cast<float>(smoothedLoad));
+
+		secondsSinceChange += budget;
+		secondsWithHeadroom = smoothedLoad < stepUpLoad ? secondsWithHeadroom + budget : 0;
+
+		const auto current = static_cast<int>(tier.load());
+		if (smoothedLoad > stepDownLoad && current < static_cast<int>(QualityTier::Economy)
+			&& secondsSinceChange >= stepDownHoldSeconds) {
+			setTier(static_cast<QualityTier>(current + 1));
+		} else if (current > static_cast<int>(QualityTier::Full) && secondsWithHeadroom >= stepUpHoldSeconds) {
+			setTier(static_cast<QualityTier>(current - 1));
+		}
+	};
 
-		M_L_B,
-		M_M_B,
-		M_H_B,
+	// Smoothed processBlock cost as a fraction of the block's real-time budget.
+	float getLoad() const { return load.load(); }
+	QualityTier getTier() const { return tier.load(); }
 
-		S_L_B,
-		S_M_B,
-		S_H_B,
-		
-		Gain_in,
-		Gain_out	
+private:
+	void setTier(QualityTier newTier) {
+		tier.store(newTier);
+		secondsSinceChange = 0;
+		secondsWithHeadroom = 0;
 	};
 
-	inline const std::map<FreqInts, juce::String>& GetParams() {
-		static std::map<FreqInts, juce::String> parameters = {
-			{L_M_CR_F, "Low-Mid Crossover Freq"},
-			{M_H_CR_F, "Mid-High Crossover Freq"},
-			{TD_L_B, "Threshold low band"},
-			{TD_M_B, "Threshold mid band"},
-			{TD_H_B, "Threshold highm band"},
-			{A_L_B, "Attack low band"},
-			{A_M_B, "Attack mid band"},
-			{A_H_B, "Attack high band"},
-			{R_L_B, "Release low band"},
-			{R_M_B, "Release mid band"},
-			{R_H_B, "Release high band"},
-			{RT_L_B, "Ratio low band"},
-			{RT_M_B, "Ratio mid band"},
-			{RT_H_B, "Ratio high band"},
-			{By_L_B, "Bypassed low band"},
-			{By_M_B, "Bypassed mid band"},
-			{By_H_B, "Bypassed high band"},
-			
-			{S_L_B, "Solo low band"},
-			{S_M_B, "Solo mid band"},
-			{S_H_B, "Solo high band"},
-			
-			{M_L_B, "Mute low band"},
-			{M_M_B, "Mute mid band"},
-			{M_H_B, "Mute high band"},
-			{Gain_in, "Gain in"},
-			{Gain_out, "Gain out"}
-
-		};
-
-		return parameters;
-	}
+	static constexpr double loadTimeConstantSeconds = 0.1;
+	static constexpr double stepDownLoad = 0.8;
+	static constexpr double stepUpLoad = 0.5;
+	// Several load time constants, so the effect of one step shows in the load before the next.
+	static constexpr double stepDownHoldSeconds = 3 * loadTimeConstantSeconds;
+	static constexpr double stepUpHoldSeconds = 2.0;
 
-}
+	double sampleRate{0};
+	double smoothedLoad{0};
+	double secondsSinceChange{0};
+	double secondsWithHeadroom{0};
+
+	std::atomic<float> load{0.f};
+	std::atomic<QualityTier> tier{QualityTier::Full};
+};
 
 //==============================================================================
 /**
@@ -167,8 +308,43 @@ public:
 
 	APVTS apvts{*this, nullptr, "Parameters", createParameterLayout()};
 
+	float getCpuLoad() const { return governor.getLoad(); }
+	QualityTier getQualityTier() const { return governor.getTier(); }
+
 
 private:
+	// Parameters are registered in Registry order, so the typed pointer is found by index
+	// instead of an ID search and a dynamic_cast.
+	template <Parameters::FreqInts Id, typename ParameterType>
+	ParameterType* getBoundParameter() const {
+		constexpr auto index = Parameters::indexOf(Id);
+		static_assert(index >= 0, "Parameter is not in Parameters::Registry");
+
+		auto* parameter = getParameters()[index];
+		jassert(dynamic_cast<ParameterType*>(parameter) != nullptr);
+		// Several parameters share a type, so also check the ID in case getParameters() stops matching Registry.
+		jassert(static_cast<ParameterType*>(parameter)->paramID == Parameters::Registry[index].name);
+		return static_cast<ParameterType*>(parameter);
+	}
+
+	template <size_t Band>
+	void bindBand() {
+		using namespace juce;
+		constexpr auto ids = Parameters::Bands[Band];
+		constexpr auto& ratioSpec = Parameters::Registry[Parameters::indexOf(ids.ratio)];
+		static_assert(ratioSpec.choices != nullptr, "Ratio parameter needs a choice list");
+		auto& band = cmds_[Band];
+
+		band.attackParameter = getBoundParameter<ids.attack, AudioParameterFloat>();
+		band.releaseParameter = getBoundParameter<ids.release, AudioParameterFloat>();
+		band.tresholdParameter = getBoundParameter<ids.threshold, AudioParameterFloat>();
+		band.ratioParameter = getBoundParameter<ids.ratio, AudioParameterChoice>();
+		band.ratioChoices = ratioSpec.choices;
+		band.byPassedParameter = getBoundParameter<ids.bypassed, AudioParameterBool>();
+		band.muteParameter = getBoundParameter<ids.mute, AudioParameterBool>();
+		band.SoloParameter = getBoundParameter<ids.solo, AudioParameterBool>();
+	}
+
 	std::array<ComprosserBand, 3> cmds_;
 	ComprosserBand& lowBandComprosser = cmds_[0];
 	ComprosserBand& midBandComprosser = cmds_[1];
@@ -179,8 +355,21 @@ private:
 
 	juce::AudioParameterFloat* lMCrossOver{nullptr};
 	juce::AudioParameterFloat* mHCrossOver{nullptr};
-	// We are using two seperate buffers to destroy the all frequency due to the effect of high pass and low pass
-	std::array<juce::AudioBuffer<float>, 3> filterBuffers;
+	// Host blocks of any size are split into quanta of this many samples, so the band
+	// scratch memory is fixed at prepareToPlay and small enough to stay in L1.
+	static constexpr int processingQuantum = 64;
+	void updateControls();
+	void processQuantum(juce::dsp::AudioBlock<float> block, const std::array<bool, 3>& bandAudible, bool lowBandAllPass);
+
+	// We are using seperate band blocks to destroy the all frequency due to the effect of high pass and low pass.
+	// All three are views into the single aligned arena allocated in prepareToPlay, together with
+	// the scratch block used to crossfade the low band all-pass in and out.
+	juce::HeapBlock<char> bandArena;
+	std::array<juce::dsp::AudioBlock<float>, 3> bandBlocks;
+	juce::dsp::AudioBlock<float> allPassFadeBlock;
+	bool allPassActive{true};
+	CpuLoadGovernor governor;
+
 	juce::dsp::Gain<float> iGain, oGain;
 	juce::AudioParameterFloat* iGainParam{ nullptr };
 	juce::AudioParameterFloat* oGainParam{ nullptr };